@@ -10,9 +10,15 @@ struct ChunkWithText {
 
 std::vector<std::string> list_text_files(const std::string& root);
 
+// Deterministic slice `shard` of `n_shards`, keyed on the path relative to
+// root so every host agrees on the split regardless of where root is mounted.
+std::vector<std::string> shard_files(const std::vector<std::string>& files, const std::string& root,
+                                     int shard, int n_shards);
+
 // Chunk by a sliding window of lines (size, overlap)
 // Records LS/LE and byte offsets (start/end) into the file for fast re-read.
 std::vector<ChunkWithText> chunk_file(const std::string& path, int size=150, int overlap=20);
 
-// Convenience: chunk an entire folder
-std::vector<ChunkWithText> chunk_folder(const std::string& root, int size=150, int overlap=20);
+// Convenience: chunk an entire folder (or one shard of it)
+std::vector<ChunkWithText> chunk_folder(const std::string& root, int size=150, int overlap=20,
+                                        int shard=0, int n_shards=1);
@@ -1,18 +1,36 @@
 #pragma once
 #include <string>
+#include <vector>
 
 struct Args {
-  std::string mode;          // "index" or "query"
+  std::string mode;          // "index", "query", "merge" or "tune"
   std::string root_path;
   std::string sqlite_path = "./index/chunks.sqlite";
   std::string hnsw_path   = "./index/vectors.hnsw";
+  std::string meta_path   = "./index/chunks.meta";
+  std::string trigram_path = "./index/chunks.tri";
   std::string instruct_model = "./models/instruct.gguf";
   std::string embed_model    = "./models/embed.gguf";
   std::string query;
+  std::vector<std::string> shard_dirs;   // merge inputs
+  std::string planner = "auto";   // off | auto | llm
   int k = 80;
   int max_hits = 20;
+  double mmr_lambda = 0.7;   // 1 = relevance only
   int chunk_size = 150;
   int chunk_overlap = 20;
+  double target_recall = 0.95;
+  int tune_queries = 200;
+  bool tune_build = false;   // also sweep M/efConstruction on a sample rebuild
+  int tune_sample = 20000;
+  int shard = 0;             // --shard i/N
+  int n_shards = 1;
+  bool resume = false;
+  bool restart = false;      // abandon an interrupted run
+  int checkpoint_every = 2000;   // chunks
+  int checkpoint_secs = 300;
+  bool use_mmap = true;
+  bool use_mlock = false;
 };
 
 Args parse_cli(int argc, char** argv);
@@ -1,11 +1,11 @@
-#include "embedder.hpp"
 #pragma once
+#include "llama_runtime.hpp"
 #include <string>
 #include <vector>
 
 class Embedder {
 public:
-  explicit Embedder(const std::string& embed_model_path);
+  explicit Embedder(const std::string& embed_model_path, const ModelOptions& opts = {});
   ~Embedder();
 
   std::vector<float> encode(const std::string& text);
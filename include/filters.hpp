@@ -1,6 +1,7 @@
 #pragma once
 #include "planner.hpp"
 #include "index.hpp"
+#include "meta_table.hpp"
 #include <string>
 #include <vector>
 
@@ -9,10 +10,12 @@ struct Hit {
   std::string file;
   int ls;
   int le;
+  size_t byte_start;
+  size_t byte_end;
   std::string snippet;
 };
 
-std::vector<Hit> apply_filters(const std::vector<int>& candidates,
+// Verify already-resolved (possibly collapsed) regions against the plan.
+std::vector<Hit> apply_filters(const std::vector<ChunkRef>& regions,
                                const Plan& plan,
-                               const Store& store,
                                int max_hits);
@@ -3,18 +3,42 @@
 #include <vector>
 #include <memory>
 
+// Tuned HNSW settings, kept next to the graph in <path>.params (JSON) and
+// picked up by Index::load. M/efConstruction only affect newly built graphs.
+struct IndexParams {
+  int M = 16;
+  int ef_construction = 200;
+  int ef_search = 64;
+  int k = 0;                    // recall@k the settings were tuned for
+  double target_recall = 0.0;
+  double measured_recall = 0.0;
+};
+
 class Index {
 public:
   Index(const std::string& path, int dim, int M=16, int efC=200, int efS=64);
   ~Index();
 
-  void add(const std::vector<float>& vec);              // append-only
+  void add(const std::vector<float>& vec);              // append-only, grows capacity
   std::vector<int> search(const std::vector<float>& q, int k) const;
+  std::vector<float> get_vector(int label) const;       // stored copy
+
+  void save() const;   // writes to <path> (temp file + rename)
+  void load();         // loads from <path> (if exists), applying <path>.params
+
+  void set_ef(int efS);
+
+  static bool read_params(const std::string& path, IndexParams& out);
+  static void write_params(const std::string& path, const IndexParams& p);
 
-  void save() const;   // writes to <path>
-  void load();         // loads from <path> (if exists)
+  // Vector dimension recorded in an existing index file, 0 if absent.
+  // Lets the HNSW graph load without waiting for the embedder.
+  static int file_dim(const std::string& path);
 
   int dim() const { return dim_; }
+  int M() const { return M_; }
+  int ef_construction() const { return efC_; }
+  int ef_search() const { return efS_; }
   size_t size() const;
 
 private:
@@ -0,0 +1,12 @@
+#pragma once
+
+// How GGUF weights are brought into memory.
+struct ModelOptions {
+  bool use_mmap = true;    // page weights in lazily from the file
+  bool use_mlock = false;  // pin them so they are never swapped out
+};
+
+// Process-wide llama backend, reference counted so Planner and Embedder can
+// be constructed (and destroyed) concurrently from different threads.
+void backend_acquire();
+void backend_release();
@@ -0,0 +1,49 @@
+#pragma once
+#include "mmap_file.hpp"
+#include "store.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Chunk metadata resolved from the flat table. `file` points into the
+// mapping (NUL-terminated) and stays valid as long as the MetaTable lives.
+struct ChunkRef {
+  int id;
+  std::string_view file;
+  uint32_t file_id;
+  int ls;
+  int le;
+  size_t byte_start;
+  size_t byte_end;
+};
+
+// Compact read-only copy of the chunks table for the query path:
+//   header | file table | path blob | rows[label]
+// Paths are interned once; each row is fixed width and indexed directly by
+// vector label, so lookups are a bounds check plus an array access.
+// SQLite stays the source of truth; this file is rebuilt from it.
+class MetaTable {
+public:
+  explicit MetaTable(const std::string& path);
+
+  // Snapshot the chunks table into <path> (temp file + rename).
+  static void write(const std::string& path, const Store& store);
+
+  bool has(int id) const;
+  ChunkRef get(int id) const;   // throws if the label has no chunk
+  std::string_view file(uint32_t file_id) const;
+
+  size_t size() const { return n_rows_; }
+  size_t n_files() const { return n_files_; }
+
+private:
+  struct FileEntry;
+  struct Row;
+
+  MappedFile map_;
+  const FileEntry* files_ = nullptr;
+  const char* blob_ = nullptr;
+  const Row* rows_ = nullptr;
+  size_t n_files_ = 0;
+  size_t n_rows_ = 0;
+};
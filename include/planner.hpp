@@ -1,4 +1,5 @@
 #pragma once
+#include "llama_runtime.hpp"
 #include <string>
 #include <vector>
 
@@ -12,11 +13,12 @@ struct Plan {
 
 class Planner {
 public:
-  Planner(const std::string& model_path);
+  explicit Planner(const std::string& model_path, const ModelOptions& opts = {});
   ~Planner();
 
   Plan compile(const std::string& natural_query);
 
 private:
-  void* ctx_; // forward-declare llama_context internally
+  struct Impl;
+  Impl* impl_;
 };
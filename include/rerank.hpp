@@ -0,0 +1,46 @@
+#pragma once
+#include "index.hpp"
+#include "meta_table.hpp"
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+// Post-search stage, run before any snippet I/O: works purely from the
+// metadata table and the vectors already held by the HNSW graph.
+
+// Merge candidates whose line ranges overlap or touch within the same file
+// into one region (ranked at its best member, whose id it keeps). Regions
+// stop growing at `max_lines` so dense exact matches don't swallow a file;
+// the next region then starts after the previous one ends.
+std::vector<ChunkRef> collapse_overlaps(const std::vector<int>& ranked, const MetaTable& meta,
+                                        int max_lines = 400);
+
+struct Region {
+  ChunkRef ref;
+  size_t rank;   // best (lowest) rank among its members
+};
+
+// Streaming collapse_overlaps for candidates pushed in id order. Ids follow
+// file order, so a file's windows arrive together and ascending, and a region
+// is final as soon as the next candidate doesn't touch it; nothing is sorted
+// or buffered beyond that open region.
+class OverlapCollapser {
+public:
+  explicit OverlapCollapser(const MetaTable& meta, int max_lines = 400)
+    : meta_(meta), max_lines_(max_lines) {}
+
+  // Returns the region this candidate closed, if any.
+  std::optional<Region> push(int id, size_t rank);
+  // Returns the open region, if any.
+  std::optional<Region> finish();
+
+private:
+  const MetaTable& meta_;
+  int max_lines_;
+  std::optional<Region> open_;
+};
+
+// Greedy MMR re-rank: lambda * sim(query, r) - (1 - lambda) * max sim to the
+// regions already picked. lambda = 1 keeps the input order.
+std::vector<ChunkRef> diversify(const std::vector<ChunkRef>& regions, const std::vector<float>& query,
+                                const Index& index, double lambda);
@@ -0,0 +1,16 @@
+#pragma once
+#include "planner.hpp"
+#include <ctime>
+#include <optional>
+#include <string>
+
+// Deterministic front end for queries that don't need the instruct model:
+//   "quoted literal"  -> exact regex        /re/ or /re/i -> regex
+//   *.log, src/**.cpp -> filename globs      a bare identifier-like token
+//                                            (10.0.0.1, 2024-05-01) -> literal
+// Date phrases (yesterday, last 7 days, 2024-05-01..2024-05-03) fill
+// time_from/time_to, but nothing filters on those yet, so they never make a
+// plan on their own. Returns nullopt for free-form queries (the LLM
+// planner's job): no literal or regex was found and words other than
+// connectives are left over.
+std::optional<Plan> rule_plan(const std::string& query, std::time_t now = std::time(nullptr));
@@ -1,4 +1,5 @@
 #pragma once
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -19,6 +20,17 @@ public:
   void ensure_schema();
   void upsert_chunk(const Chunk& c);
   Chunk get_chunk(int id) const;
+  void for_each_chunk(const std::function<void(const Chunk&)>& fn) const; // ascending id
+  size_t n_chunks() const;
+
+  // Explicit transactions, so a batch of rows lands together with the
+  // HNSW checkpoint that covers it.
+  void begin();
+  void commit();
+
+  // Small key/value table for indexing run state (high-water mark etc.).
+  void set_state(const std::string& key, const std::string& value);
+  std::string get_state(const std::string& key) const;  // "" if unset
 
 private:
   struct Impl;
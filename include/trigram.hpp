@@ -0,0 +1,67 @@
+#pragma once
+#include "mmap_file.hpp"
+#include "planner.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Trigram posting lists over chunk text, for regex/literal plans where
+// embedding similarity is the wrong tool. Trigrams are taken over
+// ASCII-lowercased bytes to line up with RE2's (case-folded) prefilter atoms.
+//
+// On disk: header | directory (sorted by trigram) | postings, where each
+// posting list is ascending chunk ids, delta + varint encoded.
+
+class TrigramIndex {
+public:
+  explicit TrigramIndex(const std::string& path);
+
+  // Ascending chunk ids that may satisfy the plan's regexes (OR'ed, as in
+  // apply_filters). Returns false if the plan cannot be narrowed, e.g. no
+  // regex or a regex with no usable literal; survivors still need RE2.
+  bool candidates(const Plan& plan, std::vector<int>& out) const;
+
+  // Chunks containing every trigram of `lit` (already lowercased).
+  bool literal(std::string_view lit, std::vector<uint32_t>& out) const;
+
+  void for_each(const std::function<void(uint32_t tri, const std::vector<uint32_t>& ids)>& fn) const;
+
+  size_t n_chunks() const { return n_chunks_; }
+
+private:
+  friend class TrigramBuilder;
+  struct Entry;
+  const Entry* find(uint32_t tri) const;
+  void decode(const Entry& e, std::vector<uint32_t>& out) const;
+
+  MappedFile map_;
+  const Entry* dir_ = nullptr;
+  const unsigned char* post_ = nullptr;
+  size_t n_terms_ = 0;
+  size_t n_chunks_ = 0;
+};
+
+class TrigramBuilder {
+public:
+  // Chunk ids must arrive in ascending order.
+  void add(int chunk_id, std::string_view text);
+  // Append an existing index's postings, shifting its ids by `offset`.
+  void add_index(const TrigramIndex& src, uint32_t offset = 0);
+
+  void write(const std::string& path) const;   // temp file + rename
+
+private:
+  // Lists are kept in their on-disk form (delta + varint) while building, so
+  // memory stays close to the final file size rather than 4+ bytes per id.
+  struct Postings {
+    std::string bytes;
+    uint32_t last = 0;
+    uint32_t count = 0;
+    void push(uint32_t id);
+  };
+  std::unordered_map<uint32_t, Postings> postings_;
+  size_t n_chunks_ = 0;
+};
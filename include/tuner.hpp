@@ -0,0 +1,20 @@
+#pragma once
+#include "index.hpp"
+
+struct TuneOptions {
+  double target_recall = 0.95;
+  int k = 10;                // recall@k, normally the query-time -k
+  int n_queries = 200;       // chunk vectors held out as queries
+  bool rebuild = false;      // also sweep M/efConstruction on a sample rebuild
+  int sample_size = 20000;   // vectors sampled for the rebuilt graphs
+  unsigned seed = 1234;
+};
+
+// Measure recall@k against brute-force neighbours and return the cheapest
+// settings that reach the target, or the best seen if none does. Queries are
+// sampled chunk vectors held out of a graph rebuilt over the rest of a
+// `sample_size` sample, so recall reflects unseen queries; efSearch comes
+// from that graph at the index's own M/efConstruction. With `rebuild`,
+// M/efConstruction are swept the same way and efSearch is the one measured
+// with the chosen pair.
+IndexParams tune_index(Index& index, const TuneOptions& opts);
@@ -1,4 +1,6 @@
 #include "chunker.hpp"
+#include <algorithm>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
@@ -22,6 +24,22 @@ std::vector<std::string> list_text_files(const std::string& root) {
     if (!is_text_ext(ext)) continue;
     out.push_back(p.path().string());
   }
+  // directory iteration order is unspecified; sort so runs are reproducible
+  std::sort(out.begin(), out.end());
+  return out;
+}
+
+std::vector<std::string> shard_files(const std::vector<std::string>& files, const std::string& root,
+                                     int shard, int n_shards) {
+  if (n_shards <= 1) return files;
+  std::vector<string> out;
+  for (auto& f : files) {
+    // FNV-1a over the root-relative path (generic separators)
+    string rel = fs::path(f).lexically_relative(root).generic_string();
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : rel) { h ^= c; h *= 1099511628211ull; }
+    if ((int)(h % (uint64_t)n_shards) == shard) out.push_back(f);
+  }
   return out;
 }
 
@@ -61,8 +79,9 @@ std::vector<ChunkWithText> chunk_file(const std::string& path, int size, int ove
   return chunks;
 }
 
-std::vector<ChunkWithText> chunk_folder(const std::string& root, int size, int overlap) {
-  auto files = list_text_files(root);
+std::vector<ChunkWithText> chunk_folder(const std::string& root, int size, int overlap,
+                                        int shard, int n_shards) {
+  auto files = shard_files(list_text_files(root), root, shard, n_shards);
   std::vector<ChunkWithText> all;
   for (auto& f : files) {
     auto v = chunk_file(f, size, overlap);
@@ -3,8 +3,11 @@
 #include <cstring>
 
 static const char* USAGE =
-"llm_grep index <root> [--sqlite path] [--hnsw path] [--embed-model path] [--chunk-size N] [--chunk-overlap N]\n"
-"llm_grep query \"text\" [--sqlite path] [--hnsw path] [--instruct-model path] [--embed-model path] [-k N] [--max-hits N]\n";
+"llm_grep index <root> [--sqlite path] [--hnsw path] [--meta path] [--trigram path] [--embed-model path] [--chunk-size N] [--chunk-overlap N] [--shard i/N] [--resume | --restart] [--checkpoint-every N] [--checkpoint-secs T] [--no-mmap] [--mlock]\n"
+"llm_grep query \"text\" [--sqlite path] [--hnsw path] [--meta path] [--trigram path] [--instruct-model path] [--embed-model path] [--planner off|auto|llm] [-k N] [--max-hits N] [--mmr-lambda L] [--no-mmap] [--mlock]\n"
+"llm_grep merge <shard_dir>... [--root dir] [--sqlite path] [--hnsw path] [--meta path] [--trigram path]\n"
+"  (each shard_dir holds chunks.sqlite, vectors.hnsw and optionally chunks.tri)\n"
+"llm_grep tune [--hnsw path] [-k N] [--target-recall R] [--tune-queries N] [--tune-build] [--tune-sample N]\n";
 
 Args parse_cli(int argc, char** argv) {
   Args a;
@@ -17,6 +20,11 @@ Args parse_cli(int argc, char** argv) {
   } else if (a.mode == "query") {
     if (i >= argc) { std::cerr << USAGE; std::exit(1); }
     a.query = argv[i++];
+  } else if (a.mode == "tune") {
+    // no positional arguments
+  } else if (a.mode == "merge") {
+    while (i < argc && argv[i][0] != '-') a.shard_dirs.push_back(argv[i++]);
+    if (a.shard_dirs.empty()) { std::cerr << USAGE; std::exit(1); }
   } else {
     std::cerr << USAGE; std::exit(1);
   }
@@ -28,14 +36,45 @@ Args parse_cli(int argc, char** argv) {
       dst = argv[i++];
     };
     if (f == "--sqlite") next(a.sqlite_path);
+    else if (f == "--root" && a.mode == "merge") next(a.root_path);
     else if (f == "--hnsw") next(a.hnsw_path);
+    else if (f == "--meta") next(a.meta_path);
+    else if (f == "--trigram") next(a.trigram_path);
     else if (f == "--instruct-model") next(a.instruct_model);
     else if (f == "--embed-model") next(a.embed_model);
+    else if (f == "--planner") {
+      next(a.planner);
+      if (a.planner != "off" && a.planner != "auto" && a.planner != "llm") {
+        std::cerr << "--planner expects off, auto or llm\n"; std::exit(1);
+      }
+    }
     else if (f == "-k") { std::string v; next(v); a.k = std::stoi(v); }
     else if (f == "--max-hits") { std::string v; next(v); a.max_hits = std::stoi(v); }
+    else if (f == "--mmr-lambda") { std::string v; next(v); a.mmr_lambda = std::stod(v); }
     else if (f == "--chunk-size") { std::string v; next(v); a.chunk_size = std::stoi(v); }
     else if (f == "--chunk-overlap") { std::string v; next(v); a.chunk_overlap = std::stoi(v); }
+    else if (f == "--checkpoint-every") { std::string v; next(v); a.checkpoint_every = std::stoi(v); }
+    else if (f == "--checkpoint-secs") { std::string v; next(v); a.checkpoint_secs = std::stoi(v); }
+    else if (f == "--shard") {
+      std::string v; next(v);
+      auto slash = v.find('/');
+      if (slash == std::string::npos) { std::cerr << "--shard expects i/N\n"; std::exit(1); }
+      a.shard = std::stoi(v.substr(0, slash));
+      a.n_shards = std::stoi(v.substr(slash + 1));
+      if (a.n_shards < 1 || a.shard < 0 || a.shard >= a.n_shards) {
+        std::cerr << "--shard " << v << " out of range\n"; std::exit(1);
+      }
+    }
+    else if (f == "--resume") a.resume = true;
+    else if (f == "--restart") a.restart = true;
+    else if (f == "--target-recall") { std::string v; next(v); a.target_recall = std::stod(v); }
+    else if (f == "--tune-queries") { std::string v; next(v); a.tune_queries = std::stoi(v); }
+    else if (f == "--tune-sample") { std::string v; next(v); a.tune_sample = std::stoi(v); }
+    else if (f == "--tune-build") a.tune_build = true;
+    else if (f == "--no-mmap") a.use_mmap = false;
+    else if (f == "--mlock") a.use_mlock = true;
     else { std::cerr << "Unknown flag: " << f << "\n"; std::exit(1); }
   }
+  if (a.resume && a.restart) { std::cerr << "--resume and --restart are mutually exclusive\n"; std::exit(1); }
   return a;
 }
@@ -14,11 +14,13 @@ struct Embedder::Impl {
   int n_ctx = 1024;
   int dim = 0;
 
-  explicit Impl(const std::string& model_path) {
-    llama_backend_init();
+  Impl(const std::string& model_path, const ModelOptions& opts) {
+    backend_acquire();
 
     llama_model_params mp = llama_model_default_params();
     mp.n_gpu_layers = 0; // CPU
+    mp.use_mmap = opts.use_mmap;
+    mp.use_mlock = opts.use_mlock;
     model = llama_load_model_from_file(model_path.c_str(), mp);
     if (!model) throw std::runtime_error("embedder: failed to load model");
 
@@ -39,7 +41,7 @@ struct Embedder::Impl {
   ~Impl() {
     if (ctx) llama_free(ctx);
     if (model) llama_free_model(model);
-    llama_backend_free();
+    backend_release();
   }
 
   std::vector<llama_token> tokenize(const std::string& text) {
@@ -82,8 +84,8 @@ struct Embedder::Impl {
   }
 };
 
-Embedder::Embedder(const std::string& embed_model_path)
-  : impl_(new Impl(embed_model_path)) {
+Embedder::Embedder(const std::string& embed_model_path, const ModelOptions& opts)
+  : impl_(new Impl(embed_model_path, opts)) {
   dim_ = impl_->dim;
 }
 
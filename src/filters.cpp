@@ -1,12 +1,16 @@
 // src/filters.cpp
 #include "filters.hpp"
 #include "planner.hpp"
-#include "store.hpp"
+#include "meta_table.hpp"
 #include <re2/re2.h>
 #include <algorithm>
 #include <fstream>
+#include <memory>
 #include <string>
 
+static const size_t MAX_VERIFY_BYTES = 1 << 20;
+static const size_t SNIPPET_BYTES = 300;
+
 static std::string read_slice(const std::string& file, size_t b0, size_t b1, size_t max_bytes=2000) {
   std::ifstream in(file, std::ios::binary);
   if (!in) return {};
@@ -17,27 +21,73 @@ static std::string read_slice(const std::string& file, size_t b0, size_t b1, siz
   return s;
 }
 
-std::vector<Hit> apply_filters(const std::vector<int>& cands,
+// Case-insensitive wildcard match: '*' any run, '?' one char.
+static bool glob_match(const char* p, const char* s) {
+  const char* star = nullptr;
+  const char* resume = nullptr;
+  while (*s) {
+    if (*p == '?' || (*p != '*' && ::tolower((unsigned char)*p) == ::tolower((unsigned char)*s))) { ++p; ++s; }
+    else if (*p == '*') { star = p++; resume = s; }
+    else if (star) { p = star + 1; s = ++resume; }
+    else return false;
+  }
+  while (*p == '*') ++p;
+  return *p == '\0';
+}
+
+// Globs without a '/' match the file name. Others match the path from any
+// component on, since stored paths carry the index root (/data/repo/src/a.cpp
+// and ./src/a.cpp both match src/*.cpp).
+static bool file_matches(const std::string& glob, const std::string& file) {
+  if (glob.find('/') != std::string::npos) {
+    if (glob_match(glob.c_str(), file.c_str())) return true;
+    for (size_t i = file.find_first_of("/\\"); i != std::string::npos; i = file.find_first_of("/\\", i + 1))
+      if (glob_match(glob.c_str(), file.c_str() + i + 1)) return true;
+    return false;
+  }
+  auto slash = file.find_last_of("/\\");
+  return glob_match(glob.c_str(), file.c_str() + (slash == std::string::npos ? 0 : slash + 1));
+}
+
+std::vector<Hit> apply_filters(const std::vector<ChunkRef>& regions,
                                const Plan& plan,
-                               const Store& store,
                                int max_hits) {
-  std::vector<RE2> regs;
+  std::vector<std::unique_ptr<RE2>> regs;
   regs.reserve(plan.regex.size());
-  for (auto& r : plan.regex) if (!r.empty()) regs.emplace_back(r);
+  for (auto& r : plan.regex) {
+    if (r.empty()) continue;
+    // (?m): ^/$ anchor at line boundaries, as in grep
+    auto re = std::make_unique<RE2>("(?m)" + r, RE2::Quiet);
+    if (re->ok()) regs.push_back(std::move(re));
+  }
+
+  // keyword filters and regexes check the text; globs need only the path
+  bool verify = !regs.empty() ||
+      std::any_of(plan.filters.begin(), plan.filters.end(),
+                  [](const std::string& f) { return f.find_first_of("*?") == std::string::npos; });
 
   std::vector<Hit> hits;
-  hits.reserve(std::min<int>(cands.size(), max_hits));
+  hits.reserve(std::min<int>(regions.size(), max_hits));
 
-  for (int id : cands) {
-    auto meta = store.get_chunk(id);
-    std::string text = read_slice(meta.file, meta.byte_start, meta.byte_end);
+  for (auto& c : regions) {
+    std::string file(c.file);
 
-    // keyword filter
+    // glob filters only need the path, so check them before any I/O
     bool ok = true;
+    for (auto& f : plan.filters) {
+      if (f.find_first_of("*?") != std::string::npos && !file_matches(f, file)) { ok = false; break; }
+    }
+    if (!ok) continue;
+
+    // verify over the whole (possibly merged) span; otherwise read just the snippet
+    std::string text = read_slice(file, c.byte_start, c.byte_end, verify ? MAX_VERIFY_BYTES : SNIPPET_BYTES);
+
+    // keyword filter
     if (!plan.filters.empty()) {
-      std::string hay = meta.file + " " + text;
+      std::string hay = file + " " + text;
       std::transform(hay.begin(), hay.end(), hay.begin(), ::tolower);
       for (auto f : plan.filters) {
+        if (f.find_first_of("*?") != std::string::npos) continue;
         std::transform(f.begin(), f.end(), f.begin(), ::tolower);
         if (hay.find(f) == std::string::npos) { ok = false; break; }
       }
@@ -48,13 +98,13 @@ std::vector<Hit> apply_filters(const std::vector<int>& cands,
     if (!regs.empty()) {
       bool any = false;
       for (auto& re : regs) {
-        if (RE2::PartialMatch(text, re)) { any = true; break; }
+        if (RE2::PartialMatch(text, *re)) { any = true; break; }
       }
       if (!any) continue;
     }
 
-    Hit h{ id, meta.file, meta.ls, meta.le,
-           text.size() > 300 ? text.substr(0,300) : text };
+    Hit h{ c.id, std::move(file), c.ls, c.le, c.byte_start, c.byte_end,
+           text.size() > SNIPPET_BYTES ? text.substr(0, SNIPPET_BYTES) : text };
     hits.push_back(std::move(h));
     if ((int)hits.size() >= max_hits) break;
   }
@@ -1,6 +1,8 @@
 #include "index.hpp"
 #include <hnswlib/hnswlib.h>
+#include <nlohmann/json.hpp>
 #include <filesystem>
+#include <fstream>
 #include <stdexcept>
 
 struct Index::Impl {
@@ -14,7 +16,52 @@ Index::Index(const std::string& path, int dim, int M, int efC, int efS)
 
 Index::~Index() = default;
 
+int Index::file_dim(const std::string& path) {
+  // hnswlib header: offsetLevel0, max_elements, cur_element_count,
+  // size_data_per_element, label_offset, offsetData (all size_t).
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return 0;
+  size_t h[6];
+  if (!in.read(reinterpret_cast<char*>(h), sizeof(h))) return 0;
+  size_t label_offset = h[4], offset_data = h[5];
+  if (label_offset <= offset_data) return 0;
+  return (int)((label_offset - offset_data) / sizeof(float));
+}
+
+bool Index::read_params(const std::string& path, IndexParams& out) {
+  std::ifstream in(path + ".params");
+  if (!in) return false;
+  try {
+    auto j = nlohmann::json::parse(in);
+    out.M               = j.value("M", out.M);
+    out.ef_construction = j.value("ef_construction", out.ef_construction);
+    out.ef_search       = j.value("ef_search", out.ef_search);
+    out.k               = j.value("k", out.k);
+    out.target_recall   = j.value("target_recall", out.target_recall);
+    out.measured_recall = j.value("measured_recall", out.measured_recall);
+  } catch (...) { return false; }
+  return true;
+}
+
+void Index::write_params(const std::string& path, const IndexParams& p) {
+  nlohmann::json j = {
+    {"M", p.M}, {"ef_construction", p.ef_construction}, {"ef_search", p.ef_search},
+    {"k", p.k}, {"target_recall", p.target_recall}, {"measured_recall", p.measured_recall},
+  };
+  std::string tmp = path + ".params.tmp";
+  {
+    std::ofstream out(tmp, std::ios::trunc);
+    if (!out) throw std::runtime_error("cannot write " + tmp);
+    out << j.dump(2) << "\n";
+  }
+  std::filesystem::rename(tmp, path + ".params");
+}
+
 void Index::load() {
+  IndexParams p;
+  if (!path_.empty() && read_params(path_, p)) {
+    M_ = p.M; efC_ = p.ef_construction; efS_ = p.ef_search;
+  }
   impl_->space.reset(new hnswlib::L2Space(dim_));
   if (std::filesystem::exists(path_)) {
     impl_->hnsw.reset(new hnswlib::HierarchicalNSW<float>(impl_->space.get(), path_));
@@ -32,12 +79,17 @@ void Index::load() {
 
 void Index::save() const {
   if (!created_) return;
-  impl_->hnsw->saveIndex(path_);
+  // write-then-rename so a crash mid-save never clobbers the last good graph
+  std::string tmp = path_ + ".tmp";
+  impl_->hnsw->saveIndex(tmp);
+  std::filesystem::rename(tmp, path_);
 }
 
 void Index::add(const std::vector<float>& vec) {
   if (!created_) load();
   if ((int)vec.size() != dim_) throw std::runtime_error("Index::add dimension mismatch");
+  size_t cap = impl_->hnsw->getMaxElements();
+  if (impl_->next_id >= cap) impl_->hnsw->resizeIndex(std::max<size_t>(cap * 2, 10000));
   impl_->hnsw->addPoint((void*)vec.data(), impl_->next_id++);
 }
 
@@ -52,6 +104,16 @@ std::vector<int> Index::search(const std::vector<float>& q, int k) const {
   return ids;
 }
 
+void Index::set_ef(int efS) {
+  efS_ = efS;
+  if (created_) impl_->hnsw->setEf(efS_);
+}
+
+std::vector<float> Index::get_vector(int label) const {
+  if (!created_) throw std::runtime_error("Index not initialized");
+  return impl_->hnsw->template getDataByLabel<float>((hnswlib::labeltype)label);
+}
+
 size_t Index::size() const {
   return created_ ? impl_->hnsw->cur_element_count.load() : 0;
 }
@@ -0,0 +1,18 @@
+#include "llama_runtime.hpp"
+#include <llama.h>
+#include <mutex>
+
+namespace {
+std::mutex g_mu;
+int g_refs = 0;
+}
+
+void backend_acquire() {
+  std::lock_guard<std::mutex> lk(g_mu);
+  if (g_refs++ == 0) llama_backend_init();
+}
+
+void backend_release() {
+  std::lock_guard<std::mutex> lk(g_mu);
+  if (--g_refs == 0) llama_backend_free();
+}
@@ -3,10 +3,26 @@
 #include "embedder.hpp"
 #include "index.hpp"
 #include "store.hpp"
+#include "meta_table.hpp"
+#include "filters.hpp"
+#include "trigram.hpp"
+#include "tuner.hpp"
+#include "rule_planner.hpp"
+#include "rerank.hpp"
 #include "chunker.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
 
 static std::string read_context(const std::string& file, size_t b0, size_t b1, int extra_lines=5) {
   // read a little more context by expanding byte window to include +/- extra_lines
@@ -32,67 +48,407 @@ static std::string read_context(const std::string& file, size_t b0, size_t b1, i
   return data.substr(start, end - start);
 }
 
+static std::string read_range(const std::string& file, size_t b0, size_t b1) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in || b1 <= b0) return {};
+  in.seekg((std::streamoff)b0);
+  std::string s; s.resize(b1 - b0);
+  in.read(s.data(), (std::streamsize)s.size());
+  s.resize((size_t)in.gcount());
+  return s;
+}
+
+// Map `file` from under `from` to the same relative path under `to`;
+// paths outside `from` are returned unchanged.
+static std::string rebase_path(const std::string& file, const std::string& from, const std::string& to) {
+  namespace fs = std::filesystem;
+  auto rel = fs::path(file).lexically_relative(from);
+  if (rel.empty() || *rel.begin() == "..") return file;
+  return (fs::path(to) / rel).string();
+}
+
+// Feed chunks [0, n) of `store` into the trigram builder as ids offset..,
+// reusing the postings at `tri_path` when they line up with them and
+// otherwise re-reading the chunk text from disk (no re-embedding needed).
+// `map_path` translates stored paths to where the files live locally.
+static void seed_trigrams(TrigramBuilder& tb, const std::string& tri_path, const Store& store,
+                          size_t n, uint32_t offset=0,
+                          const std::function<std::string(const std::string&)>& map_path = {}) {
+  if (n == 0) return;
+  if (std::filesystem::exists(tri_path)) {
+    TrigramIndex old(tri_path);
+    if (old.n_chunks() == n) { tb.add_index(old, offset); return; }
+  }
+  std::cerr << "Rebuilding trigram postings for " << n << " existing chunks\n";
+  store.for_each_chunk([&](const Chunk& c) {
+    if (c.id < 0 || (size_t)c.id >= n) return;
+    const std::string file = map_path ? map_path(c.file) : c.file;
+    tb.add((int)(c.id + offset), read_range(file, c.byte_start, c.byte_end));
+  });
+}
+
+// Hits for exact (trigram-verified) candidates: regions holding a vector
+// search result come first, in that order, then the rest in file order.
+// Survivors are streamed in id order, so a common literal never resolves or
+// sorts the whole set: the scan stops once every vector-ranked survivor is
+// placed and enough of the tail has passed verification.
+static std::vector<Hit> exact_hits(const std::vector<int>& vec_ids, const std::vector<int>& exact,
+                                   const Plan& plan, const MetaTable& meta, int max_hits) {
+  const size_t unranked = std::numeric_limits<size_t>::max();
+  std::unordered_map<int, size_t> vec_rank;
+  for (size_t r = 0; r < vec_ids.size(); ++r)
+    if (std::binary_search(exact.begin(), exact.end(), vec_ids[r])) vec_rank.emplace(vec_ids[r], r);
+
+  std::vector<Region> ranked;
+  std::vector<ChunkRef> pending;
+  std::vector<Hit> tail;
+  auto verify_pending = [&] {
+    for (auto& h : apply_filters(pending, plan, max_hits - (int)tail.size())) tail.push_back(std::move(h));
+    pending.clear();
+  };
+  auto take = [&](const Region& g) {
+    if (g.rank != unranked) { ranked.push_back(g); return; }
+    if ((int)tail.size() >= max_hits) return;
+    pending.push_back(g.ref);
+    if ((int)pending.size() >= max_hits) verify_pending();
+  };
+
+  OverlapCollapser collapser(meta);
+  size_t placed = 0;
+  for (int id : exact) {
+    if (placed == vec_rank.size() && (int)tail.size() >= max_hits) break;
+    auto it = vec_rank.find(id);
+    if (it != vec_rank.end()) ++placed;
+    if (auto g = collapser.push(id, it == vec_rank.end() ? unranked : it->second)) take(*g);
+  }
+  if (auto g = collapser.finish()) take(*g);
+  if (!pending.empty() && (int)tail.size() < max_hits) verify_pending();
+
+  std::sort(ranked.begin(), ranked.end(), [](const Region& a, const Region& b) { return a.rank < b.rank; });
+  std::vector<ChunkRef> refs;
+  refs.reserve(ranked.size());
+  for (auto& g : ranked) refs.push_back(g.ref);
+  auto hits = apply_filters(refs, plan, max_hits);
+  for (auto& h : tail) {
+    if ((int)hits.size() >= max_hits) break;
+    hits.push_back(std::move(h));
+  }
+  return hits;
+}
+
+// Rebuild the flat metadata table if it is missing or older than SQLite.
+static void refresh_meta(const std::string& meta_path, const std::string& sqlite_path, const Store& store) {
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  if (fs::exists(meta_path, ec) &&
+      fs::last_write_time(meta_path, ec) >= fs::last_write_time(sqlite_path, ec)) return;
+  MetaTable::write(meta_path, store);
+}
+
 int main(int argc, char** argv) {
   auto args = parse_cli(argc, argv);
+  ModelOptions mo;
+  mo.use_mmap = args.use_mmap;
+  mo.use_mlock = args.use_mlock;
 
   if (args.mode == "index") {
     Store store(args.sqlite_path);
     Index idx(args.hnsw_path, /*dim*/ 0); // will reset after embedder knows dim
 
-    Embedder emb(args.embed_model);
+    Embedder emb(args.embed_model, mo);
     Index index(args.hnsw_path, emb.dim());
     index.load();
 
-    auto chunks = chunk_folder(args.root_path, args.chunk_size, args.chunk_overlap);
+    // Run state lives in SQLite. Rows are committed before the HNSW graph is
+    // saved at each checkpoint, so the saved graph size is the high-water
+    // mark: everything below it is both embedded and has its row.
+    size_t base = index.size();
+    size_t done = 0;
+    if (args.resume) {
+      if (store.get_state("run_status") != "running") {
+        std::cerr << "No interrupted indexing run to resume\n";
+        return 1;
+      }
+      if (store.get_state("run_root") != args.root_path) {
+        std::cerr << "Interrupted run was for " << store.get_state("run_root") << ", not " << args.root_path << "\n";
+        return 1;
+      }
+      base = std::stoul(store.get_state("run_base"));
+      args.chunk_size = std::stoi(store.get_state("run_chunk_size"));
+      args.chunk_overlap = std::stoi(store.get_state("run_chunk_overlap"));
+      if (!store.get_state("run_n_shards").empty()) {
+        args.shard = std::stoi(store.get_state("run_shard"));
+        args.n_shards = std::stoi(store.get_state("run_n_shards"));
+      }
+      if (index.size() < base) {
+        std::cerr << "HNSW file is older than the interrupted run; cannot resume\n";
+        return 1;
+      }
+      done = index.size() - base;
+    } else if (store.get_state("run_status") == "running") {
+      size_t run_base = std::stoul(store.get_state("run_base"));
+      size_t partial = index.size() > run_base ? index.size() - run_base : 0;
+      if (!args.restart) {
+        std::cerr << "Previous indexing run was interrupted; use --resume to continue it, or --restart to "
+                     "start over (its " << partial << " partial chunks stay in the index)\n";
+        return 1;
+      }
+      std::cerr << "Starting a new run; the interrupted run's " << partial
+                << " partial chunks stay in the index\n";
+    }
+
+    auto chunks = chunk_folder(args.root_path, args.chunk_size, args.chunk_overlap,
+                               args.shard, args.n_shards);
+    if (args.resume && std::to_string(chunks.size()) != store.get_state("run_total")) {
+      std::cerr << "Files under " << args.root_path << " changed since the interrupted run; cannot resume\n";
+      return 1;
+    }
+    if (done > chunks.size()) {
+      std::cerr << "Index holds more chunks than the interrupted run produced; cannot resume\n";
+      return 1;
+    }
 
-    int id = (int)index.size();  // continue appending
-    for (auto& cwt : chunks) {
+    if (!args.resume) {
+      store.begin();
+      store.set_state("run_status", "running");
+      store.set_state("run_root", args.root_path);
+      store.set_state("run_base", std::to_string(base));
+      store.set_state("run_total", std::to_string(chunks.size()));
+      store.set_state("run_chunk_size", std::to_string(args.chunk_size));
+      store.set_state("run_chunk_overlap", std::to_string(args.chunk_overlap));
+      store.set_state("run_shard", std::to_string(args.shard));
+      store.set_state("run_n_shards", std::to_string(args.n_shards));
+      store.set_state("run_done", "0");
+      store.commit();
+    } else {
+      std::cerr << "Resuming at chunk " << done << " of " << chunks.size() << "\n";
+    }
+
+    TrigramBuilder trigrams;
+    seed_trigrams(trigrams, args.trigram_path, store, base);
+    for (size_t i = 0; i < done; ++i) trigrams.add((int)(base + i), chunks[i].text);
+
+    using clock = std::chrono::steady_clock;
+    auto last_ckpt = clock::now();
+    size_t ckpt_done = done;
+    auto checkpoint = [&] {
+      store.set_state("run_done", std::to_string(done));
+      store.commit();
+      index.save();
+      last_ckpt = clock::now();
+      ckpt_done = done;
+      std::cerr << "Checkpoint at id " << (base + done) << "\n";
+    };
+
+    store.begin();
+    while (done < chunks.size()) {
+      auto& cwt = chunks[done];
       auto v = emb.encode(cwt.text);
       index.add(v);
 
       Chunk meta = cwt.meta;
-      meta.id = id++;
+      meta.id = (int)(base + done);
       store.upsert_chunk(meta);
+      trigrams.add(meta.id, cwt.text);
+      ++done;
 
       if ((meta.id % 500) == 0) std::cerr << "Indexed up to id " << meta.id << "\n";
+
+      if ((args.checkpoint_every > 0 && done - ckpt_done >= (size_t)args.checkpoint_every) ||
+          (args.checkpoint_secs > 0 &&
+           clock::now() - last_ckpt >= std::chrono::seconds(args.checkpoint_secs))) {
+        checkpoint();
+        store.begin();
+      }
+    }
+    checkpoint();
+    store.set_state("run_status", "complete");
+    MetaTable::write(args.meta_path, store);
+    trigrams.write(args.trigram_path);
+    std::cerr << "Done.\n";
+    return 0;
+  }
+
+  if (args.mode == "merge") {
+    // Concatenate shard label spaces in argument order. HNSW graphs can't be
+    // spliced, so the stored vectors are re-inserted (no re-embedding).
+    // With --root, each shard's paths are moved from the root it indexed to
+    // that root on this machine, so hosts can mount the tree anywhere.
+    namespace fs = std::filesystem;
+    Store store(args.sqlite_path);
+    int dim = Index::file_dim((fs::path(args.shard_dirs[0]) / "vectors.hnsw").string());
+    Index index(args.hnsw_path, dim);
+    index.load();
+    if (index.size() != 0) {
+      std::cerr << "Merge target " << args.hnsw_path << " is not empty\n";
+      return 1;
+    }
+    // Rows are committed per shard but the graph is saved only at the end,
+    // so rows without a graph are left over from a failed merge.
+    if (store.n_chunks() != 0) {
+      std::cerr << "Merge target " << args.sqlite_path << " already has chunks"
+                << " (left over from a failed merge?); remove it and re-run\n";
+      return 1;
+    }
+
+    TrigramBuilder trigrams;
+    uint32_t offset = 0;
+    for (auto& dir : args.shard_dirs) {
+      auto shard_sqlite = (fs::path(dir) / "chunks.sqlite").string();
+      auto shard_hnsw   = (fs::path(dir) / "vectors.hnsw").string();
+      if (!fs::exists(shard_sqlite) || !fs::exists(shard_hnsw)) {
+        std::cerr << "Shard " << dir << " is missing chunks.sqlite or vectors.hnsw\n";
+        return 1;
+      }
+      if (Index::file_dim(shard_hnsw) != dim) {
+        std::cerr << "Shard " << dir << " has dimension " << Index::file_dim(shard_hnsw)
+                  << ", expected " << dim << "\n";
+        return 1;
+      }
+      Store shard_store(shard_sqlite);
+      if (shard_store.get_state("run_status") == "running") {
+        std::cerr << "Shard " << dir << " has an unfinished indexing run; resume it first\n";
+        return 1;
+      }
+      std::function<std::string(const std::string&)> map_path;
+      if (!args.root_path.empty()) {
+        std::string shard_root = shard_store.get_state("run_root");
+        if (shard_root.empty()) {
+          std::cerr << "Shard " << dir << " does not record its root; cannot apply --root\n";
+          return 1;
+        }
+        map_path = [shard_root, &args](const std::string& f) { return rebase_path(f, shard_root, args.root_path); };
+      }
+
+      Index shard_index(shard_hnsw, dim);
+      shard_index.load();
+      size_t n = shard_index.size();
+
+      for (size_t label = 0; label < n; ++label) index.add(shard_index.get_vector((int)label));
+
+      store.begin();
+      shard_store.for_each_chunk([&](const Chunk& c) {
+        if (c.id < 0 || (size_t)c.id >= n) return;
+        Chunk m = c;
+        m.id = (int)(c.id + offset);
+        if (map_path) m.file = map_path(c.file);
+        store.upsert_chunk(m);
+      });
+      store.commit();
+
+      seed_trigrams(trigrams, (fs::path(dir) / "chunks.tri").string(), shard_store, n, offset, map_path);
+      std::cerr << "Merged " << dir << ": " << n << " chunks at ids " << offset << "..\n";
+      offset += (uint32_t)n;
     }
     index.save();
+    MetaTable::write(args.meta_path, store);
+    trigrams.write(args.trigram_path);
     std::cerr << "Done.\n";
     return 0;
   }
 
+  if (args.mode == "tune") {
+    Index index(args.hnsw_path, Index::file_dim(args.hnsw_path));
+    if (index.dim() == 0) {
+      std::cerr << "No index at " << args.hnsw_path << "\n";
+      return 1;
+    }
+    index.load();
+
+    TuneOptions opts;
+    opts.target_recall = args.target_recall;
+    opts.k = args.k;
+    opts.n_queries = args.tune_queries;
+    opts.rebuild = args.tune_build;
+    opts.sample_size = args.tune_sample;
+    auto p = tune_index(index, opts);
+
+    Index::write_params(args.hnsw_path, p);
+    std::cerr << "Saved efSearch=" << p.ef_search << " M=" << p.M << " efConstruction=" << p.ef_construction
+              << " (recall@" << p.k << "=" << p.measured_recall << ") to " << args.hnsw_path << ".params\n";
+    return 0;
+  }
+
   if (args.mode == "query") {
+    // Planner load + generation runs on its own thread; the embedder and the
+    // HNSW graph load in parallel with it, so the vector search finishes
+    // while the plan is still being generated. The metadata table (which
+    // may need rebuilding from SQLite) is opened meanwhile on this thread.
+    // Simple queries (literals, /regex/, globs, dates) are planned by rules
+    // and never load the instruct model; "off" never loads it at all.
+    std::optional<Plan> fast;
+    if (args.planner != "llm") fast = rule_plan(args.query);
+    if (!fast && args.planner == "off") fast = Plan{};
+    std::future<Plan> plan_f;
+    if (fast) {
+      plan_f = std::async(std::launch::deferred, [p = *fast] { return p; });
+    } else {
+      plan_f = std::async(std::launch::async, [&] {
+        Planner planner(args.instruct_model, mo);
+        return planner.compile(args.query);
+      });
+    }
+    auto index_f = std::async(std::launch::async, [&] {
+      auto ix = std::make_unique<Index>(args.hnsw_path, Index::file_dim(args.hnsw_path));
+      ix->load();
+      return ix;
+    });
+    auto qv_f = std::async(std::launch::async, [&] {
+      Embedder emb(args.embed_model, mo);
+      return std::make_pair(emb.encode(args.query), emb.dim());
+    });
+
     Store store(args.sqlite_path);
-    Planner planner(args.instruct_model);
-    Embedder emb(args.embed_model);
-    Index index(args.hnsw_path, emb.dim());
-    index.load();
+    refresh_meta(args.meta_path, args.sqlite_path, store);
+    MetaTable meta(args.meta_path);
+    std::unique_ptr<TrigramIndex> trigrams;
+    if (std::filesystem::exists(args.trigram_path)) {
+      trigrams = std::make_unique<TrigramIndex>(args.trigram_path);
+      if (trigrams->n_chunks() < meta.size()) {
+        std::cerr << "Trigram index is stale; re-run index to rebuild it\n";
+        trigrams.reset();
+      }
+    }
 
-    auto plan = planner.compile(args.query);
-    auto qv = emb.encode(args.query);
-    auto ids = index.search(qv, args.k);
+    auto [qv, emb_dim] = qv_f.get();
+    auto index = index_f.get();
+    if (index->dim() != emb_dim) {
+      std::cerr << "Index dimension " << index->dim() << " does not match embedder dimension "
+                << emb_dim << "\n";
+      return 1;
+    }
+    auto ids = index->search(qv, args.k);
 
-    // Apply light keyword/regex filtering inline (or use your earlier filters.cpp)
-    // Here: load chunk meta, read the chunk text, apply simple contains (for brevity)
-    // If you already have filters.cpp with RE2, call that instead.
+    auto plan = plan_f.get();
+    // Regex/literal plans go through the trigram index: its survivors are a
+    // superset of every exact match, so RE2 verification in apply_filters
+    // gives grep-exact results instead of whatever the top k happened to hold.
+    //
+    // Overlapping windows of one region become a single hit, and similarity
+    // results are spread with MMR, before any snippet is read from disk.
+    std::vector<int> exact;
+    std::vector<Hit> hits;
+    if (trigrams && trigrams->candidates(plan, exact)) {
+      hits = exact_hits(ids, exact, plan, meta, args.max_hits);
+    } else {
+      auto regions = diversify(collapse_overlaps(ids, meta), qv, *index, args.mmr_lambda);
+      hits = apply_filters(regions, plan, args.max_hits);
+    }
 
     // Print plan
-    std::cout << "Plan:\n  filters=";
+    std::cout << "Plan" << (fast ? " (rules)" : "") << ":\n  filters=";
     for (auto& f : plan.filters) std::cout << f << " ";
     std::cout << "\n  regex=";
     for (auto& r : plan.regex) std::cout << r << " ";
     std::cout << "\n\n";
 
-    int shown = 0;
-    for (int id : ids) {
-      auto c = store.get_chunk(id);
-      auto ctx = read_context(c.file, c.byte_start, c.byte_end, /*extra_lines=*/5);
-      std::cout << c.file << ":" << c.ls << "-" << c.le << "\n";
+    for (auto& h : hits) {
+      auto ctx = read_context(h.file, h.byte_start, h.byte_end, /*extra_lines=*/5);
+      std::cout << h.file << ":" << h.ls << "-" << h.le << "\n";
       // truncate display
       if (ctx.size() > 1200) ctx.resize(1200);
       // show with line breaks intact
       std::cout << ctx << "\n---\n";
-      if (++shown >= args.max_hits) break;
     }
     return 0;
   }
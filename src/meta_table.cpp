@@ -0,0 +1,132 @@
+#include "meta_table.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+const char MAGIC[8] = {'L','G','M','E','T','A','0','1'};
+const uint32_t VERSION = 1;
+const uint32_t NO_FILE = 0xFFFFFFFFu;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t n_files;
+  uint64_t n_rows;
+  uint64_t files_off;
+  uint64_t blob_off;
+  uint64_t blob_size;
+  uint64_t rows_off;
+};
+
+uint64_t align8(uint64_t x) { return (x + 7) & ~uint64_t(7); }
+}
+
+struct MetaTable::FileEntry {
+  uint64_t offset;   // into the path blob
+  uint32_t length;   // excluding the trailing NUL
+  uint32_t reserved;
+};
+
+struct MetaTable::Row {
+  uint32_t file_id;  // NO_FILE marks a label with no chunk row
+  int32_t ls;
+  int32_t le;
+  uint32_t reserved;
+  uint64_t byte_start;
+  uint64_t byte_end;
+};
+
+void MetaTable::write(const std::string& path, const Store& store) {
+  std::vector<std::string> paths;
+  std::unordered_map<std::string, uint32_t> path_ids;
+  std::vector<Row> rows;
+
+  store.for_each_chunk([&](const Chunk& c) {
+    if (c.id < 0) return;
+    auto it = path_ids.find(c.file);
+    if (it == path_ids.end()) {
+      it = path_ids.emplace(c.file, (uint32_t)paths.size()).first;
+      paths.push_back(c.file);
+    }
+    if ((size_t)c.id >= rows.size()) rows.resize((size_t)c.id + 1, Row{ NO_FILE, 0, 0, 0, 0, 0 });
+    rows[c.id] = Row{ it->second, c.ls, c.le, 0,
+                      (uint64_t)c.byte_start, (uint64_t)c.byte_end };
+  });
+
+  std::vector<FileEntry> files;
+  files.reserve(paths.size());
+  std::string blob;
+  for (auto& p : paths) {
+    files.push_back(FileEntry{ (uint64_t)blob.size(), (uint32_t)p.size(), 0 });
+    blob.append(p);
+    blob.push_back('\0');
+  }
+
+  Header h{};
+  std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+  h.version = VERSION;
+  h.n_files = (uint32_t)files.size();
+  h.n_rows = rows.size();
+  h.files_off = align8(sizeof(Header));
+  h.blob_off = h.files_off + files.size() * sizeof(FileEntry);
+  h.blob_size = blob.size();
+  h.rows_off = align8(h.blob_off + h.blob_size);
+
+  std::string tmp = path + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("meta: cannot write " + tmp);
+    auto pad_to = [&](uint64_t off) {
+      static const char zeros[8] = {};
+      auto cur = (uint64_t)out.tellp();
+      if (off > cur) out.write(zeros, (std::streamsize)(off - cur));
+    };
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    pad_to(h.files_off);
+    out.write(reinterpret_cast<const char*>(files.data()), (std::streamsize)(files.size() * sizeof(FileEntry)));
+    out.write(blob.data(), (std::streamsize)blob.size());
+    pad_to(h.rows_off);
+    out.write(reinterpret_cast<const char*>(rows.data()), (std::streamsize)(rows.size() * sizeof(Row)));
+    if (!out) throw std::runtime_error("meta: short write " + tmp);
+  }
+  std::filesystem::rename(tmp, path);
+}
+
+MetaTable::MetaTable(const std::string& path) : map_(path) {
+  if (map_.empty()) throw std::runtime_error("meta: cannot open " + path);
+  if (map_.size() < sizeof(Header)) throw std::runtime_error("meta: truncated " + path);
+  const auto* h = reinterpret_cast<const Header*>(map_.data());
+  if (std::memcmp(h->magic, MAGIC, sizeof(MAGIC)) != 0 || h->version != VERSION)
+    throw std::runtime_error("meta: bad header " + path);
+  if (h->files_off + (uint64_t)h->n_files * sizeof(FileEntry) > map_.size() ||
+      h->blob_off + h->blob_size > map_.size() ||
+      h->rows_off + h->n_rows * sizeof(Row) > map_.size())
+    throw std::runtime_error("meta: truncated " + path);
+
+  files_ = reinterpret_cast<const FileEntry*>(map_.data() + h->files_off);
+  blob_  = reinterpret_cast<const char*>(map_.data() + h->blob_off);
+  rows_  = reinterpret_cast<const Row*>(map_.data() + h->rows_off);
+  n_files_ = h->n_files;
+  n_rows_  = (size_t)h->n_rows;
+}
+
+bool MetaTable::has(int id) const {
+  return id >= 0 && (size_t)id < n_rows_ && rows_[id].file_id != NO_FILE;
+}
+
+std::string_view MetaTable::file(uint32_t file_id) const {
+  if (file_id >= n_files_) return {};
+  const auto& f = files_[file_id];
+  return std::string_view(blob_ + f.offset, f.length);
+}
+
+ChunkRef MetaTable::get(int id) const {
+  if (!has(id)) throw std::runtime_error("chunk id not found");
+  const Row& r = rows_[id];
+  return ChunkRef{ id, file(r.file_id), r.file_id, r.ls, r.le,
+                   (size_t)r.byte_start, (size_t)r.byte_end };
+}
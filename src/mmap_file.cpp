@@ -0,0 +1,71 @@
+#include "mmap_file.hpp"
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& path) {
+  HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (f == INVALID_HANDLE_VALUE) return;
+  LARGE_INTEGER sz;
+  if (!GetFileSizeEx(f, &sz) || sz.QuadPart == 0) { CloseHandle(f); return; }
+  HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!m) { CloseHandle(f); throw std::runtime_error("mmap failed: " + path); }
+  void* p = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+  if (!p) { CloseHandle(m); CloseHandle(f); throw std::runtime_error("mmap failed: " + path); }
+  file_ = f;
+  mapping_ = m;
+  data_ = static_cast<const unsigned char*>(p);
+  size_ = (size_t)sz.QuadPart;
+}
+
+void MappedFile::reset() {
+  if (data_) UnmapViewOfFile(data_);
+  if (mapping_) CloseHandle((HANDLE)mapping_);
+  if (file_) CloseHandle((HANDLE)file_);
+  data_ = nullptr; size_ = 0; mapping_ = nullptr; file_ = nullptr;
+}
+#else
+MappedFile::MappedFile(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return;
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return; }
+  void* p = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd); // the mapping keeps its own reference
+  if (p == MAP_FAILED) throw std::runtime_error("mmap failed: " + path);
+  data_ = static_cast<const unsigned char*>(p);
+  size_ = (size_t)st.st_size;
+}
+
+void MappedFile::reset() {
+  if (data_) ::munmap(const_cast<unsigned char*>(data_), size_);
+  data_ = nullptr; size_ = 0;
+}
+#endif
+
+MappedFile::~MappedFile() { reset(); }
+
+MappedFile::MappedFile(MappedFile&& o) noexcept { *this = std::move(o); }
+
+MappedFile& MappedFile::operator=(MappedFile&& o) noexcept {
+  if (this != &o) {
+    reset();
+    std::swap(data_, o.data_);
+    std::swap(size_, o.size_);
+#ifdef _WIN32
+    std::swap(file_, o.file_);
+    std::swap(mapping_, o.mapping_);
+#endif
+  }
+  return *this;
+}
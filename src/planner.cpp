@@ -45,11 +45,13 @@ struct Planner::Impl {
   const llama_vocab* vocab = nullptr;
   int n_ctx = 2048;
 
-  explicit Impl(const std::string& model_path) {
-    llama_backend_init();
+  Impl(const std::string& model_path, const ModelOptions& opts) {
+    backend_acquire();
 
     llama_model_params mp = llama_model_default_params();
     mp.n_gpu_layers = 0;
+    mp.use_mmap = opts.use_mmap;
+    mp.use_mlock = opts.use_mlock;
     model = llama_load_model_from_file(model_path.c_str(), mp);
     if (!model) throw std::runtime_error("planner: failed to load model");
 
@@ -68,7 +70,7 @@ struct Planner::Impl {
   ~Impl() {
     if (ctx) llama_free(ctx);
     if (model) llama_free_model(model);
-    llama_backend_free();
+    backend_release();
   }
 
   std::vector<llama_token> tokenize(const std::string& s, bool add_bos=true) {
@@ -166,5 +168,6 @@ Plan Planner::compile(const std::string& natural_query) {
   return p;
 }
 
-Planner::Planner(const std::string& model_path) : impl_(new Impl(model_path)) {}
+Planner::Planner(const std::string& model_path, const ModelOptions& opts)
+  : impl_(new Impl(model_path, opts)) {}
 Planner::~Planner() { delete impl_; }
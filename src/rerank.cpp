@@ -0,0 +1,108 @@
+#include "rerank.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace {
+float dot(const std::vector<float>& a, const std::vector<float>& b) {
+  float s = 0.f;
+  for (size_t i = 0; i < a.size() && i < b.size(); ++i) s += a[i] * b[i];
+  return s;
+}
+
+// Fold `it` (which starts at or after `cur`) into `cur` if they overlap or
+// touch. Over the cap, drop what the region already covers, and start the
+// rest where the region ends so regions in one file never intersect.
+// Returns true if `it` was absorbed; otherwise `it` starts a new region.
+bool absorb(Region& cur, Region& it, int max_lines) {
+  bool touches = cur.ref.file_id == it.ref.file_id && it.ref.ls <= cur.ref.le + 1;
+  if (!touches) return false;
+  if (std::max(cur.ref.le, it.ref.le) - cur.ref.ls + 1 <= max_lines) {
+    cur.ref.le = std::max(cur.ref.le, it.ref.le);
+    cur.ref.byte_end = std::max(cur.ref.byte_end, it.ref.byte_end);
+    if (it.rank < cur.rank) { cur.rank = it.rank; cur.ref.id = it.ref.id; }
+    return true;
+  }
+  if (it.ref.le <= cur.ref.le) {
+    if (it.rank < cur.rank) { cur.rank = it.rank; cur.ref.id = it.ref.id; }
+    return true;
+  }
+  it.ref.ls = cur.ref.le + 1;
+  it.ref.byte_start = std::max(it.ref.byte_start, cur.ref.byte_end);
+  return false;
+}
+}
+
+std::vector<ChunkRef> collapse_overlaps(const std::vector<int>& ranked, const MetaTable& meta, int max_lines) {
+  std::vector<Region> items;
+  items.reserve(ranked.size());
+  for (size_t r = 0; r < ranked.size(); ++r) {
+    if (!meta.has(ranked[r])) continue;
+    items.push_back(Region{ meta.get(ranked[r]), r });
+  }
+  std::sort(items.begin(), items.end(), [](const Region& a, const Region& b) {
+    if (a.ref.file_id != b.ref.file_id) return a.ref.file_id < b.ref.file_id;
+    return a.ref.ls < b.ref.ls;
+  });
+
+  std::vector<Region> regions;
+  for (auto& it : items) {
+    if (!regions.empty() && absorb(regions.back(), it, max_lines)) continue;
+    regions.push_back(it);
+  }
+
+  std::sort(regions.begin(), regions.end(), [](const Region& a, const Region& b) { return a.rank < b.rank; });
+  std::vector<ChunkRef> out;
+  out.reserve(regions.size());
+  for (auto& r : regions) out.push_back(r.ref);
+  return out;
+}
+
+std::optional<Region> OverlapCollapser::push(int id, size_t rank) {
+  if (!meta_.has(id)) return std::nullopt;
+  Region it{ meta_.get(id), rank };
+  if (open_ && absorb(*open_, it, max_lines_)) return std::nullopt;
+  auto done = open_;
+  open_ = it;
+  return done;
+}
+
+std::optional<Region> OverlapCollapser::finish() {
+  auto done = open_;
+  open_.reset();
+  return done;
+}
+
+std::vector<ChunkRef> diversify(const std::vector<ChunkRef>& regions, const std::vector<float>& query,
+                                const Index& index, double lambda) {
+  if (lambda >= 1.0 || regions.size() < 3) return regions;
+
+  // Embeddings are L2-normalized, so the dot product is the cosine.
+  std::vector<std::vector<float>> vecs;
+  std::vector<float> rel;
+  vecs.reserve(regions.size());
+  for (auto& r : regions) {
+    vecs.push_back(index.get_vector(r.id));
+    rel.push_back(dot(query, vecs.back()));
+  }
+
+  std::vector<ChunkRef> out;
+  out.reserve(regions.size());
+  std::vector<char> picked(regions.size(), 0);
+  std::vector<float> max_sim(regions.size(), -std::numeric_limits<float>::infinity());
+  for (size_t n = 0; n < regions.size(); ++n) {
+    size_t best = regions.size();
+    double best_score = -std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < regions.size(); ++i) {
+      if (picked[i]) continue;
+      double redundancy = out.empty() ? 0.0 : (double)max_sim[i];
+      double score = lambda * rel[i] - (1.0 - lambda) * redundancy;
+      if (score > best_score) { best_score = score; best = i; }
+    }
+    picked[best] = 1;
+    out.push_back(regions[best]);
+    for (size_t i = 0; i < regions.size(); ++i) {
+      if (!picked[i]) max_sim[i] = std::max(max_sim[i], dot(vecs[i], vecs[best]));
+    }
+  }
+  return out;
+}
@@ -0,0 +1,160 @@
+// src/rule_planner.cpp
+#include "rule_planner.hpp"
+#include <re2/re2.h>
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <unordered_set>
+
+namespace {
+const char* REGEX_META = "\\()[]{}^$|+";
+
+bool has_any(const std::string& s, const char* chars) {
+  return s.find_first_of(chars) != std::string::npos;
+}
+
+bool valid_regex(const std::string& r) {
+  RE2 re(r, RE2::Quiet);
+  return re.ok();
+}
+
+std::string iso_day(std::time_t now, int days_back) {
+  std::time_t t = now - (std::time_t)days_back * 86400;
+  std::tm tm = *std::localtime(&t);
+  char buf[16];
+  std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+  return buf;
+}
+
+// A glob needs a path-like shape around a wildcard (*.log, src/**, a?.txt),
+// so a question mark ending a word ("deadlock?") isn't mistaken for one.
+bool is_glob(const std::string& tok) {
+  if (!has_any(tok, "*?") || has_any(tok, REGEX_META)) return false;
+  for (size_t i = 0; i < tok.size(); ++i) {
+    if (tok[i] != '*' && tok[i] != '?') continue;
+    auto path_char = [](char c) { return c == '.' || c == '/' || c == '*'; };
+    if ((i > 0 && path_char(tok[i-1])) || (i + 1 < tok.size() && path_char(tok[i+1]))) return true;
+  }
+  return false;
+}
+
+// Drop sentence punctuation from the end of a word ("why?", "10.0.0.1.").
+std::string strip_trailing_punct(std::string w) {
+  while (w.size() > 1 && std::string(".,;:!?").find(w.back()) != std::string::npos) w.pop_back();
+  return w;
+}
+
+// Tokens like 10.0.0.1, 0xdeadbeef, NullPointerException:42, foo_bar, a/b.c
+bool is_identifier_like(const std::string& tok) {
+  bool alpha_only = std::all_of(tok.begin(), tok.end(), [](unsigned char c) { return std::isalpha(c); });
+  return !alpha_only && tok.find_first_of(" \t") == std::string::npos;
+}
+
+// Pull "...", `...` and /re/flags spans out of `q`, leaving spaces behind.
+void take_literals(std::string& q, Plan& p) {
+  for (size_t i = 0; i < q.size(); ++i) {
+    char open = q[i];
+    if (open != '"' && open != '`' && open != '/') continue;
+    if (open == '/' && i > 0 && !std::isspace((unsigned char)q[i-1])) continue;
+    size_t close = q.find(open, i + 1);
+    if (close == std::string::npos || close == i + 1) continue;
+
+    std::string body = q.substr(i + 1, close - i - 1);
+    size_t end = close + 1;
+    if (open == '/') {
+      bool icase = end < q.size() && q[end] == 'i';
+      if (icase) ++end;
+      // "/var/log/" style paths aren't regexes: require a token boundary
+      if (end < q.size() && !std::isspace((unsigned char)q[end])) continue;
+      std::string re = icase ? "(?i)" + body : body;
+      if (!valid_regex(re)) continue;
+      p.regex.push_back(re);
+    } else {
+      p.regex.push_back(RE2::QuoteMeta(body));
+    }
+    q.replace(i, end - i, std::string(end - i, ' '));
+    i = end - 1;
+  }
+}
+
+// Date phrases on the lowercased query; the matched text is blanked out.
+void take_dates(std::string& q, Plan& p, std::time_t now) {
+  static const RE2 range("(?:between|from)\\s+(\\d{4}-\\d{2}-\\d{2})\\s+(?:and|to|until|through)\\s+(\\d{4}-\\d{2}-\\d{2})");
+  static const RE2 dots("(\\d{4}-\\d{2}-\\d{2})\\s*\\.\\.\\s*(\\d{4}-\\d{2}-\\d{2})");
+  static const RE2 since("(?:since|after|from)\\s+(\\d{4}-\\d{2}-\\d{2})");
+  static const RE2 until("(?:before|until)\\s+(\\d{4}-\\d{2}-\\d{2})");
+  static const RE2 day("(?:on\\s+)?(\\d{4}-\\d{2}-\\d{2})");
+  static const RE2 last_n("\\b(?:in\\s+the\\s+)?(?:last|past)\\s+(\\d+)\\s+days?\\b");
+  static const RE2 last_week("\\b(?:in\\s+the\\s+)?(?:last|past)\\s+week\\b");
+  static const RE2 yesterday("\\byesterday\\b");
+  static const RE2 today("\\btoday\\b");
+
+  std::string a, b;
+  int n = 0;
+  if (RE2::PartialMatch(q, range, &a, &b) && RE2::Replace(&q, range, " ")) { p.time_from = a; p.time_to = b; }
+  else if (RE2::PartialMatch(q, dots, &a, &b) && RE2::Replace(&q, dots, " ")) { p.time_from = a; p.time_to = b; }
+  else if (RE2::PartialMatch(q, since, &a) && RE2::Replace(&q, since, " ")) {
+    p.time_from = a;
+    if (RE2::PartialMatch(q, until, &b) && RE2::Replace(&q, until, " ")) p.time_to = b;
+  }
+  else if (RE2::PartialMatch(q, until, &b) && RE2::Replace(&q, until, " ")) p.time_to = b;
+  else if (RE2::PartialMatch(q, day, &a) && RE2::Replace(&q, day, " ")) { p.time_from = a; p.time_to = a; }
+  else if (RE2::PartialMatch(q, last_n, &n) && RE2::Replace(&q, last_n, " ")) { p.time_from = iso_day(now, n); p.time_to = iso_day(now, 0); }
+  else if (RE2::Replace(&q, last_week, " ")) { p.time_from = iso_day(now, 7); p.time_to = iso_day(now, 0); }
+  else if (RE2::Replace(&q, yesterday, " ")) { p.time_from = p.time_to = iso_day(now, 1); }
+  else if (RE2::Replace(&q, today, " ")) { p.time_from = p.time_to = iso_day(now, 0); }
+}
+
+bool is_connective(const std::string& w) {
+  static const std::unordered_set<std::string> words = {
+    "in", "on", "of", "for", "the", "a", "an", "and", "or", "with", "from", "to", "at",
+    "file", "files", "line", "lines", "log", "logs", "containing", "contains", "matching",
+    "match", "matches", "grep", "find", "search", "show", "list", "all", "any", "where",
+  };
+  return words.count(w) > 0;
+}
+}
+
+std::optional<Plan> rule_plan(const std::string& query, std::time_t now) {
+  Plan p;
+  std::string q = query;
+
+  // A single bare token: glob or literal identifier.
+  std::string trimmed = q;
+  trimmed.erase(0, trimmed.find_first_not_of(" \t\r\n"));
+  trimmed.erase(trimmed.find_last_not_of(" \t\r\n") + 1);
+  if (!trimmed.empty() && trimmed.find_first_of(" \t\"`") == std::string::npos && trimmed[0] != '/') {
+    if (is_glob(trimmed)) { p.filters.push_back(trimmed); return p; }
+    // Only /.../ is a regex; a stack frame like Bar.baz(Bar.java:42) or
+    // OutOfMemoryError[heap] is searched for as written.
+    // A lone date is grepped for as written; a range can't be, so it is
+    // left to the date rules below.
+    std::string word = strip_trailing_punct(trimmed);
+    if (is_identifier_like(word) && !RE2::FullMatch(word, "\\d{4}-\\d{2}-\\d{2}\\.\\.\\d{4}-\\d{2}-\\d{2}")) {
+      p.regex.push_back(RE2::QuoteMeta(word));
+      return p;
+    }
+  }
+
+  take_literals(q, p);
+  std::transform(q.begin(), q.end(), q.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+  take_dates(q, p, now);
+
+  bool leftover = false;
+  std::istringstream words(q);
+  std::string w;
+  while (words >> w) {
+    w = strip_trailing_punct(w);
+    if (is_glob(w)) { p.filters.push_back(w); continue; }
+    w.erase(std::remove_if(w.begin(), w.end(), [](unsigned char c) { return std::ispunct(c); }), w.end());
+    if (!w.empty() && !is_connective(w)) leftover = true;
+  }
+
+  // Literal/regex anchors make the plan exact regardless of the rest (the
+  // embedding still sees the whole query); otherwise only accept the plan
+  // when nothing but connectives remain. Nothing applies time_from/time_to
+  // yet, so a date alone doesn't make a plan.
+  if (!p.regex.empty()) return p;
+  if (!leftover && !p.filters.empty()) return p;
+  return std::nullopt;
+}
@@ -4,6 +4,15 @@
 
 struct Store::Impl {
   sqlite3* db = nullptr;
+
+  void exec(const char* sql, const char* what) {
+    char* err=nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &err) != SQLITE_OK) {
+      std::string e = err ? err : "unknown";
+      sqlite3_free(err);
+      throw std::runtime_error(std::string("sqlite ") + what + ": " + e);
+    }
+  }
 };
 
 Store::Store(const std::string& path) : impl_(new Impl) {
@@ -29,13 +38,45 @@ void Store::ensure_schema() {
     " le INTEGER NOT NULL,"
     " byte_start INTEGER NOT NULL,"
     " byte_end INTEGER NOT NULL"
+    ");"
+    "CREATE TABLE IF NOT EXISTS state ("
+    " key TEXT PRIMARY KEY,"
+    " value TEXT NOT NULL"
     ");";
-  char* err=nullptr;
-  if (sqlite3_exec(impl_->db, sql, nullptr, nullptr, &err) != SQLITE_OK) {
-    std::string e = err ? err : "unknown";
-    sqlite3_free(err);
-    throw std::runtime_error("sqlite schema: " + e);
+  impl_->exec(sql, "schema");
+}
+
+void Store::begin() { impl_->exec("BEGIN IMMEDIATE;", "begin"); }
+
+void Store::commit() { impl_->exec("COMMIT;", "commit"); }
+
+void Store::set_state(const std::string& key, const std::string& value) {
+  const char* sql =
+    "INSERT INTO state (key, value) VALUES (?, ?) "
+    "ON CONFLICT(key) DO UPDATE SET value=excluded.value;";
+  sqlite3_stmt* st=nullptr;
+  if (sqlite3_prepare_v2(impl_->db, sql, -1, &st, nullptr) != SQLITE_OK)
+    throw std::runtime_error("sqlite prepare failed");
+  sqlite3_bind_text(st, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(st, 2, value.c_str(), -1, SQLITE_TRANSIENT);
+  if (sqlite3_step(st) != SQLITE_DONE) {
+    sqlite3_finalize(st);
+    throw std::runtime_error("sqlite state write failed");
   }
+  sqlite3_finalize(st);
+}
+
+std::string Store::get_state(const std::string& key) const {
+  const char* sql = "SELECT value FROM state WHERE key=?";
+  sqlite3_stmt* st=nullptr;
+  if (sqlite3_prepare_v2(impl_->db, sql, -1, &st, nullptr) != SQLITE_OK)
+    throw std::runtime_error("sqlite prepare failed");
+  sqlite3_bind_text(st, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+  std::string v;
+  if (sqlite3_step(st) == SQLITE_ROW)
+    v = reinterpret_cast<const char*>(sqlite3_column_text(st, 0));
+  sqlite3_finalize(st);
+  return v;
 }
 
 void Store::upsert_chunk(const Chunk& c) {
@@ -84,3 +125,34 @@ Chunk Store::get_chunk(int id) const {
   sqlite3_finalize(st);
   return c;
 }
+
+void Store::for_each_chunk(const std::function<void(const Chunk&)>& fn) const {
+  const char* sql =
+    "SELECT id, file, ls, le, byte_start, byte_end FROM chunks ORDER BY id";
+  sqlite3_stmt* st=nullptr;
+  if (sqlite3_prepare_v2(impl_->db, sql, -1, &st, nullptr) != SQLITE_OK)
+    throw std::runtime_error("sqlite prepare failed");
+  int rc;
+  while ((rc = sqlite3_step(st)) == SQLITE_ROW) {
+    Chunk c;
+    c.id   = sqlite3_column_int(st, 0);
+    c.file = reinterpret_cast<const char*>(sqlite3_column_text(st, 1));
+    c.ls   = sqlite3_column_int(st, 2);
+    c.le   = sqlite3_column_int(st, 3);
+    c.byte_start = (size_t)sqlite3_column_int64(st, 4);
+    c.byte_end   = (size_t)sqlite3_column_int64(st, 5);
+    fn(c);
+  }
+  sqlite3_finalize(st);
+  if (rc != SQLITE_DONE) throw std::runtime_error("sqlite scan failed");
+}
+
+size_t Store::n_chunks() const {
+  sqlite3_stmt* st=nullptr;
+  if (sqlite3_prepare_v2(impl_->db, "SELECT COUNT(*) FROM chunks", -1, &st, nullptr) != SQLITE_OK)
+    throw std::runtime_error("sqlite prepare failed");
+  size_t n = 0;
+  if (sqlite3_step(st) == SQLITE_ROW) n = (size_t)sqlite3_column_int64(st, 0);
+  sqlite3_finalize(st);
+  return n;
+}
@@ -0,0 +1,250 @@
+#include "trigram.hpp"
+#include <re2/re2.h>
+#include <re2/prefilter.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+const char MAGIC[8] = {'L','G','T','R','I','0','0','1'};
+const uint32_t VERSION = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t n_chunks;
+  uint64_t n_terms;
+  uint64_t dir_off;
+  uint64_t post_off;
+  uint64_t post_size;
+};
+
+inline unsigned char lower(unsigned char c) {
+  return (c >= 'A' && c <= 'Z') ? (unsigned char)(c - 'A' + 'a') : c;
+}
+
+inline uint32_t tri_key(unsigned char a, unsigned char b, unsigned char c) {
+  return ((uint32_t)a << 16) | ((uint32_t)b << 8) | (uint32_t)c;
+}
+
+void put_varint(std::string& out, uint32_t v) {
+  while (v >= 0x80) { out.push_back((char)(v | 0x80)); v >>= 7; }
+  out.push_back((char)v);
+}
+
+void intersect(std::vector<uint32_t>& acc, const std::vector<uint32_t>& other) {
+  std::vector<uint32_t> r;
+  std::set_intersection(acc.begin(), acc.end(), other.begin(), other.end(), std::back_inserter(r));
+  acc.swap(r);
+}
+
+void unite(std::vector<uint32_t>& acc, const std::vector<uint32_t>& other) {
+  std::vector<uint32_t> r;
+  std::set_union(acc.begin(), acc.end(), other.begin(), other.end(), std::back_inserter(r));
+  acc.swap(r);
+}
+
+// Candidate set for a prefilter node; `all` means "cannot narrow".
+struct CandSet {
+  bool all = true;
+  std::vector<uint32_t> ids;
+};
+}
+
+struct TrigramIndex::Entry {
+  uint32_t trigram;
+  uint32_t count;
+  uint64_t offset;   // into the postings blob
+};
+
+TrigramIndex::TrigramIndex(const std::string& path) : map_(path) {
+  if (map_.empty()) throw std::runtime_error("trigram: cannot open " + path);
+  if (map_.size() < sizeof(Header)) throw std::runtime_error("trigram: truncated " + path);
+  const auto* h = reinterpret_cast<const Header*>(map_.data());
+  if (std::memcmp(h->magic, MAGIC, sizeof(MAGIC)) != 0 || h->version != VERSION)
+    throw std::runtime_error("trigram: bad header " + path);
+  if (h->dir_off + h->n_terms * sizeof(Entry) > map_.size() ||
+      h->post_off + h->post_size > map_.size())
+    throw std::runtime_error("trigram: truncated " + path);
+  dir_  = reinterpret_cast<const Entry*>(map_.data() + h->dir_off);
+  post_ = map_.data() + h->post_off;
+  n_terms_  = (size_t)h->n_terms;
+  n_chunks_ = (size_t)h->n_chunks;
+}
+
+const TrigramIndex::Entry* TrigramIndex::find(uint32_t tri) const {
+  const Entry* end = dir_ + n_terms_;
+  const Entry* it = std::lower_bound(dir_, end, tri,
+                                     [](const Entry& e, uint32_t t) { return e.trigram < t; });
+  return (it != end && it->trigram == tri) ? it : nullptr;
+}
+
+void TrigramIndex::decode(const Entry& e, std::vector<uint32_t>& out) const {
+  out.clear();
+  out.reserve(e.count);
+  const unsigned char* p = post_ + e.offset;
+  uint32_t prev = 0;
+  for (uint32_t i = 0; i < e.count; ++i) {
+    uint32_t v = 0; int shift = 0;
+    while (*p & 0x80) { v |= (uint32_t)(*p++ & 0x7f) << shift; shift += 7; }
+    v |= (uint32_t)(*p++) << shift;
+    prev += v;
+    out.push_back(prev);
+  }
+}
+
+bool TrigramIndex::literal(std::string_view lit, std::vector<uint32_t>& out) const {
+  // Short or non-ASCII atoms can't be matched against byte-lowered trigrams.
+  if (lit.size() < 3) return false;
+  for (unsigned char c : lit) if (c >= 0x80) return false;
+
+  std::vector<uint32_t> tris;
+  for (size_t i = 0; i + 2 < lit.size(); ++i)
+    tris.push_back(tri_key(lower(lit[i]), lower(lit[i+1]), lower(lit[i+2])));
+  std::sort(tris.begin(), tris.end());
+  tris.erase(std::unique(tris.begin(), tris.end()), tris.end());
+
+  // Intersect rarest-first so the working set shrinks fast.
+  std::vector<const Entry*> es;
+  for (uint32_t t : tris) {
+    const Entry* e = find(t);
+    if (!e) { out.clear(); return true; }
+    es.push_back(e);
+  }
+  std::sort(es.begin(), es.end(), [](const Entry* a, const Entry* b) { return a->count < b->count; });
+
+  std::vector<uint32_t> ids;
+  decode(*es[0], out);
+  for (size_t i = 1; i < es.size() && !out.empty(); ++i) {
+    decode(*es[i], ids);
+    intersect(out, ids);
+  }
+  return true;
+}
+
+static CandSet eval_prefilter(const TrigramIndex& ix, re2::Prefilter* p) {
+  CandSet r;
+  switch (p->op()) {
+    case re2::Prefilter::ALL:
+      return r;
+    case re2::Prefilter::NONE:
+      r.all = false;
+      return r;
+    case re2::Prefilter::ATOM:
+      r.all = !ix.literal(p->atom(), r.ids);
+      return r;
+    case re2::Prefilter::AND:
+      for (auto* sub : *p->subs()) {
+        CandSet s = eval_prefilter(ix, sub);
+        if (s.all) continue;
+        if (r.all) { r = std::move(s); continue; }
+        intersect(r.ids, s.ids);
+        if (r.ids.empty()) break;
+      }
+      return r;
+    case re2::Prefilter::OR:
+      r.all = false;
+      for (auto* sub : *p->subs()) {
+        CandSet s = eval_prefilter(ix, sub);
+        if (s.all) return CandSet{};
+        unite(r.ids, s.ids);
+      }
+      return r;
+  }
+  return r;
+}
+
+bool TrigramIndex::candidates(const Plan& plan, std::vector<int>& out) const {
+  out.clear();
+  std::vector<uint32_t> acc;
+  bool any = false;
+  for (auto& pat : plan.regex) {
+    if (pat.empty()) continue;
+    RE2 re("(?m)" + pat, RE2::Quiet);   // same flags as apply_filters
+    if (!re.ok()) continue;   // apply_filters skips it too
+    std::unique_ptr<re2::Prefilter> pf(re2::Prefilter::FromRE2(&re));
+    if (!pf) return false;
+    CandSet s = eval_prefilter(*this, pf.get());
+    if (s.all) return false;
+    unite(acc, s.ids);
+    any = true;
+  }
+  if (!any) return false;
+  out.assign(acc.begin(), acc.end());
+  return true;
+}
+
+void TrigramIndex::for_each(const std::function<void(uint32_t, const std::vector<uint32_t>&)>& fn) const {
+  std::vector<uint32_t> ids;
+  for (size_t i = 0; i < n_terms_; ++i) {
+    decode(dir_[i], ids);
+    fn(dir_[i].trigram, ids);
+  }
+}
+
+void TrigramBuilder::Postings::push(uint32_t id) {
+  if (count > 0 && id == last) return;   // already listed for this chunk
+  put_varint(bytes, count > 0 ? id - last : id);
+  last = id;
+  ++count;
+}
+
+void TrigramBuilder::add(int chunk_id, std::string_view text) {
+  if (chunk_id < 0) return;
+  uint32_t id = (uint32_t)chunk_id;
+  for (size_t i = 0; i + 2 < text.size(); ++i)
+    postings_[tri_key(lower(text[i]), lower(text[i+1]), lower(text[i+2]))].push(id);
+  n_chunks_ = std::max(n_chunks_, (size_t)id + 1);
+}
+
+void TrigramBuilder::add_index(const TrigramIndex& src, uint32_t offset) {
+  src.for_each([&](uint32_t tri, const std::vector<uint32_t>& ids) {
+    auto& v = postings_[tri];
+    for (uint32_t id : ids) v.push(id + offset);
+  });
+  n_chunks_ = std::max(n_chunks_, src.n_chunks() + offset);
+}
+
+void TrigramBuilder::write(const std::string& path) const {
+  std::vector<uint32_t> keys;
+  keys.reserve(postings_.size());
+  for (auto& kv : postings_) keys.push_back(kv.first);
+  std::sort(keys.begin(), keys.end());
+
+  std::vector<TrigramIndex::Entry> dir;
+  dir.reserve(keys.size());
+  uint64_t post_size = 0;
+  for (uint32_t k : keys) {
+    const auto& pl = postings_.at(k);
+    dir.push_back(TrigramIndex::Entry{ k, pl.count, post_size });
+    post_size += pl.bytes.size();
+  }
+
+  Header h{};
+  std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+  h.version = VERSION;
+  h.n_chunks = n_chunks_;
+  h.n_terms = dir.size();
+  h.dir_off = sizeof(Header);
+  h.post_off = h.dir_off + dir.size() * sizeof(TrigramIndex::Entry);
+  h.post_size = post_size;
+
+  std::string tmp = path + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("trigram: cannot write " + tmp);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char*>(dir.data()), (std::streamsize)(dir.size() * sizeof(TrigramIndex::Entry)));
+    for (uint32_t k : keys) {
+      const auto& bytes = postings_.at(k).bytes;
+      out.write(bytes.data(), (std::streamsize)bytes.size());
+    }
+    if (!out) throw std::runtime_error("trigram: short write " + tmp);
+  }
+  std::filesystem::rename(tmp, path);
+}
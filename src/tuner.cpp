@@ -0,0 +1,222 @@
+#include "tuner.hpp"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+const int EF_GRID[] = {10, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024};
+const int M_GRID[] = {8, 12, 16, 24, 32, 48};
+const int EFC_GRID[] = {100, 200, 400};
+
+struct SweepPoint {
+  int ef;
+  double recall;
+  double us_per_query;
+};
+
+using Fetch = std::function<std::vector<float>(size_t)>;
+
+// Exact neighbours of one query, plus the k-th distance so that results tied
+// with a true neighbour (duplicate log lines embed identically) count as hits.
+struct Truth {
+  std::vector<int> ids;
+  float kth = 0.f;
+};
+
+float l2sq(const float* a, const float* b, size_t d) {
+  float s = 0.f;
+  for (size_t i = 0; i < d; ++i) { float t = a[i] - b[i]; s += t * t; }
+  return s;
+}
+
+// Exact k nearest ids in [0, n) for each query.
+// Streams the stored vectors once, split across threads.
+std::vector<Truth> exact_knn(const std::vector<std::vector<float>>& qs,
+                             size_t n, const Fetch& fetch, int k) {
+  using Heap = std::priority_queue<std::pair<float, int>>;   // max-heap on distance
+  unsigned n_threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::vector<Heap>> partial(n_threads, std::vector<Heap>(qs.size()));
+
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < n_threads; ++t) {
+    pool.emplace_back([&, t] {
+      auto& heaps = partial[t];
+      for (size_t id = t; id < n; id += n_threads) {
+        auto v = fetch(id);
+        for (size_t q = 0; q < qs.size(); ++q) {
+          float d = l2sq(qs[q].data(), v.data(), v.size());
+          auto& h = heaps[q];
+          if ((int)h.size() < k) h.emplace(d, (int)id);
+          else if (d < h.top().first) { h.pop(); h.emplace(d, (int)id); }
+        }
+      }
+    });
+  }
+  for (auto& th : pool) th.join();
+
+  std::vector<Truth> gt(qs.size());
+  for (size_t q = 0; q < qs.size(); ++q) {
+    Heap merged;
+    for (auto& heaps : partial) {
+      while (!heaps[q].empty()) {
+        auto e = heaps[q].top(); heaps[q].pop();
+        if ((int)merged.size() < k) merged.push(e);
+        else if (e.first < merged.top().first) { merged.pop(); merged.push(e); }
+      }
+    }
+    if (!merged.empty()) gt[q].kth = merged.top().first;
+    while (!merged.empty()) { gt[q].ids.push_back(merged.top().second); merged.pop(); }
+  }
+  return gt;
+}
+
+SweepPoint measure(Index& ix, int ef, const std::vector<std::vector<float>>& qs,
+                   const std::vector<Truth>& gt, int k, const Fetch& fetch) {
+  ix.set_ef(ef);
+  std::vector<std::vector<int>> results(qs.size());
+  auto t0 = Clock::now();
+  for (size_t q = 0; q < qs.size(); ++q) results[q] = ix.search(qs[q], k);
+  double us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+
+  size_t found = 0, total = 0;
+  for (size_t q = 0; q < qs.size(); ++q) {
+    std::unordered_set<int> truth(gt[q].ids.begin(), gt[q].ids.end());
+    for (int id : results[q]) {
+      if (truth.count(id)) { ++found; continue; }
+      auto v = fetch((size_t)id);
+      if (l2sq(qs[q].data(), v.data(), v.size()) <= gt[q].kth * (1.f + 1e-5f)) ++found;
+    }
+    total += gt[q].ids.size();
+  }
+  return SweepPoint{ ef, total ? (double)found / total : 1.0, us / std::max<size_t>(1, qs.size()) };
+}
+
+// Sweep efSearch upward, stopping at the first value that meets the target.
+// Returns that point, or the best-recall point if none qualifies.
+SweepPoint sweep(Index& ix, const std::vector<std::vector<float>>& qs, const std::vector<Truth>& gt,
+                 int k, double target, const Fetch& fetch, bool verbose) {
+  SweepPoint best{ 0, -1.0, 0.0 };
+  for (int ef : EF_GRID) {
+    if (ef < k && ef != EF_GRID[0]) continue;
+    auto p = measure(ix, std::max(ef, k), qs, gt, k, fetch);
+    if (verbose)
+      std::cerr << "  efSearch=" << p.ef << "  recall@" << k << "=" << p.recall
+                << "  " << p.us_per_query << " us/query\n";
+    if (p.recall >= target) return p;
+    if (p.recall > best.recall) best = p;
+  }
+  return best;
+}
+
+std::vector<int> sample_ids(size_t n, size_t m, std::mt19937& rng) {
+  std::vector<int> ids;
+  if (m >= n) {
+    ids.resize(n);
+    for (size_t i = 0; i < n; ++i) ids[i] = (int)i;
+    return ids;
+  }
+  std::unordered_set<int> seen;
+  std::uniform_int_distribution<size_t> pick(0, n - 1);
+  while (ids.size() < m) {
+    int id = (int)pick(rng);
+    if (seen.insert(id).second) ids.push_back(id);
+  }
+  return ids;
+}
+}
+
+IndexParams tune_index(Index& index, const TuneOptions& o) {
+  size_t n = index.size();
+  if (n < (size_t)o.k + 2) throw std::runtime_error("tune: index has too few vectors");
+  std::mt19937 rng(o.seed);
+
+  IndexParams p;
+  p.M = index.M();
+  p.ef_construction = index.ef_construction();
+  p.k = o.k;
+  p.target_recall = o.target_recall;
+
+  // Split a sample of the stored vectors into queries and a base that graphs
+  // are rebuilt from, so every recall is measured on vectors the graph has
+  // never seen.
+  auto s_labels = sample_ids(n, (size_t)o.sample_size, rng);
+  auto held = sample_ids(s_labels.size(), std::min((size_t)o.n_queries, s_labels.size() / 2), rng);
+  std::vector<char> is_query(s_labels.size(), 0);
+  for (int i : held) is_query[i] = 1;
+
+  std::vector<std::vector<float>> base, qs;
+  base.reserve(s_labels.size() - held.size());
+  for (size_t i = 0; i < s_labels.size(); ++i) {
+    auto v = index.get_vector(s_labels[i]);
+    (is_query[i] ? qs : base).push_back(std::move(v));
+  }
+  if (base.size() < (size_t)o.k + 1) throw std::runtime_error("tune: sample too small");
+
+  Fetch fetch = [&](size_t id) { return base[id]; };
+  std::cerr << "Computing exact neighbours for " << qs.size() << " held-out queries over "
+            << base.size() << " vectors\n";
+  auto gt = exact_knn(qs, base.size(), fetch, o.k);
+
+  auto build_and_sweep = [&](int M, int efC, bool verbose) {
+    Index tmp("", index.dim(), M, efC);
+    tmp.load();
+    auto t0 = Clock::now();
+    for (auto& v : base) tmp.add(v);
+    double build_s = std::chrono::duration<double>(Clock::now() - t0).count();
+    auto sp = sweep(tmp, qs, gt, o.k, o.target_recall, fetch, verbose);
+    std::cerr << "  M=" << M << " efConstruction=" << efC << "  build " << build_s << " s  "
+              << (sp.recall >= o.target_recall ? "meets target" : "misses target") << " at efSearch=" << sp.ef
+              << "  recall=" << sp.recall << "  " << sp.us_per_query << " us/query\n";
+    return sp;
+  };
+
+  // efSearch for the current build settings.
+  std::cerr << "Sweeping efSearch (M=" << p.M << ", efConstruction=" << p.ef_construction << ")\n";
+  auto current = build_and_sweep(p.M, p.ef_construction, /*verbose=*/true);
+  p.ef_search = current.ef;
+  p.measured_recall = current.recall;
+  if (current.recall < o.target_recall)
+    std::cerr << "Target recall " << o.target_recall << " not reached; best was " << current.recall
+              << " at efSearch=" << current.ef << "\n";
+
+  if (o.rebuild) {
+    // Pick M/efConstruction for future builds by the cheapest query latency
+    // that still reaches the target, keeping the efSearch measured with them.
+    bool found = false;
+    SweepPoint best{ 0, 0.0, 0.0 };
+    int best_M = p.M, best_efC = p.ef_construction;
+    for (int M : M_GRID) {
+      for (int efC : EFC_GRID) {
+        auto sp = (M == p.M && efC == p.ef_construction) ? current : build_and_sweep(M, efC, /*verbose=*/false);
+        if (sp.recall >= o.target_recall && (!found || sp.us_per_query < best.us_per_query)) {
+          found = true;
+          best = sp;
+          best_M = M;
+          best_efC = efC;
+        }
+      }
+    }
+    if (!found) {
+      std::cerr << "No sampled M/efConstruction met the target; keeping current build settings\n";
+    } else {
+      p.M = best_M;
+      p.ef_construction = best_efC;
+      p.ef_search = best.ef;
+      p.measured_recall = best.recall;
+      if (p.M != index.M() || p.ef_construction != index.ef_construction())
+        std::cerr << "efSearch=" << p.ef_search << " assumes M=" << p.M << ", efConstruction="
+                  << p.ef_construction << "; re-run index to rebuild the graph with them\n";
+    }
+  }
+
+  index.set_ef(p.ef_search);
+  return p;
+}